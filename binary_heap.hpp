@@ -1,7 +1,9 @@
 #ifndef BINARY_HEAP_HPP
 #define BINARY_HEAP_HPP
+#include <cstddef>
 #include <functional>
 #include <vector>
+#include "parallel.hpp"
 
 namespace com_masaers {
 
@@ -24,9 +26,9 @@ namespace com_masaers {
     typedef typename std::decay<Comp>::type comp_type;
   protected:
     struct node_t {
-      template<typename CallValue>
-      inline node_t(CallValue&& value, position_type position)
-	: value_m(std::forward<CallValue>(value)), position_m(position)
+      template<typename... Args>
+      inline node_t(position_type position, Args&&... args)
+	: value_m(std::forward<Args>(args)...), position_m(position)
       {}
       inline node_t(const node_t&) = default;
       inline node_t(node_t&&) = default;
@@ -50,16 +52,81 @@ namespace com_masaers {
 		const Comp& comp = Comp())
       : container_m(), comp_m(comp), priority_ex_m(priority_ex)
     {}
-    binary_heap(const binary_heap&) = default;
+    binary_heap(const binary_heap& x)
+      : container_m(x.container_m), comp_m(x.comp_m), priority_ex_m(x.priority_ex_m)
+    {
+      for (auto it = container_m.begin(); it != container_m.end(); ++it) {
+	*it = new node_t(**it);
+      }
+    }
     binary_heap(binary_heap&&) = default;
+    ~binary_heap() { clear(); }
+    binary_heap& operator=(binary_heap x) {
+      swap(*this, x);
+      return *this;
+    }
+    friend void swap(binary_heap& a, binary_heap& b) {
+      using std::swap;
+      swap(a.container_m, b.container_m);
+      swap(a.comp_m, b.comp_m);
+      swap(a.priority_ex_m, b.priority_ex_m);
+    }
     template<typename CallValue>
-    inline handle_type push(CallValue value) {
-      handle_type result = new node_t(std::forward<CallValue>(value),
-				       container_m.size());
+    inline handle_type push(CallValue&& value) {
+      return emplace(std::forward<CallValue>(value));
+    }
+    ///
+    /// Constructs a value in place from the supplied arguments and
+    /// pushes it, without copying or moving the value itself.
+    ///
+    template<typename... Args>
+    inline handle_type emplace(Args&&... args) {
+      handle_type result = new node_t(container_m.size(),
+				       std::forward<Args>(args)...);
       container_m.push_back(result);
       bubble_up(result);
       return result;
     }
+    ///
+    /// Pushes all values in [first, last) as one batch. The nodes are
+    /// constructed concurrently on up to threads threads (zero means
+    /// one per hardware thread) and then merged in by a parallel
+    /// bottom-up heapify of the affected subtrees. Pushing a batch into
+    /// an empty heap is a parallel bulk construction.
+    ///
+    template<typename RandomIt>
+    void insert(RandomIt first, RandomIt last, unsigned int threads = 0) {
+      const position_type old_size = container_m.size();
+      container_m.resize(old_size + (last - first), NULL);
+      try {
+	internal::parallel_for(old_size, container_m.size(), threads, 1 << 10,
+			       [&](position_type position) {
+				 container_m[position] = new node_t(position, first[position - old_size]);
+			       });
+      } catch (...) {
+	for (position_type position = old_size; position < container_m.size(); ++position) {
+	  delete container_m[position];
+	}
+	container_m.resize(old_size);
+	throw;
+      }
+      internal::parallel_heapify(container_m.size(), old_size, threads,
+				 [&](position_type position) {
+				   bubble_down(container_m[position]);
+				 });
+    }
+    ///
+    /// Restores the heap property of the entire heap, for use after the
+    /// priorities of many values have been changed in place through
+    /// their handles. Independent subtrees are heapified concurrently
+    /// on up to threads threads.
+    ///
+    void heapify(unsigned int threads = 0) {
+      internal::parallel_heapify(container_m.size(), 0, threads,
+				 [&](position_type position) {
+				   bubble_down(container_m[position]);
+				 });
+    }
     inline const value_type& top() const {
       return container_m.front()->value_m;
     }
@@ -67,9 +134,37 @@ namespace com_masaers {
       swap_nodes(container_m.front(), container_m.back());
       delete container_m.back();
       container_m.pop_back();
-      bubble_down(container_m.front());
+      if (! container_m.empty()) {
+	bubble_down(container_m.front());
+      }
+    }
+    ///
+    /// Pops the top and returns it, moving it out of the heap rather
+    /// than copying it.
+    ///
+    value_type pop_value() {
+      value_type result(std::move(container_m.front()->value_m));
+      pop();
+      return result;
+    }
+    void erase(handle_type node) {
+      handle_type replacement = container_m.back();
+      swap_nodes(node, replacement);
+      delete container_m.back();
+      container_m.pop_back();
+      if (replacement != node) {
+	bubble_up(replacement);
+	bubble_down(replacement);
+      }
     }
     bool empty() const { return container_m.empty(); }
+    std::size_t size() const { return container_m.size(); }
+    void clear() {
+      for (auto it = container_m.begin(); it != container_m.end(); ++it) {
+	delete *it;
+      }
+      container_m.clear();
+    }
     const_iterator begin() const { return container_m.begin(); }
     const_iterator end() const { return container_m.end(); }
     const_iterator cbegin() const { return container_m.begin(); }
@@ -77,20 +172,20 @@ namespace com_masaers {
     template<typename CallValue>
     void update(handle_type node, CallValue&& new_value) {
       if (comp_m(new_value, priority_ex_m(node->value_m))) {
-	priority_ex_m(node->value_m) = new_value;
+	priority_ex_m(node->value_m) = std::forward<CallValue>(new_value);
 	bubble_up(node);
       } else if (comp_m(priority_ex_m(node->value_m), new_value)) {
-	priority_ex_m(node->value_m) = new_value;
+	priority_ex_m(node->value_m) = std::forward<CallValue>(new_value);
 	bubble_down(node);
       } else {
-	priority_ex_m(node->value_m) = new_value;
+	priority_ex_m(node->value_m) = std::forward<CallValue>(new_value);
       }
     }
     template<typename CallValue>
     bool ensure_priority(handle_type node, CallValue&& new_value) {
       bool result = false;
       if (comp_m(new_value, priority_ex_m(node->value_m))) {
-	node->value_m = new_value;
+	priority_ex_m(node->value_m) = std::forward<CallValue>(new_value);
 	bubble_up(node);
 	result = true;
       }
@@ -2,6 +2,39 @@
 #include <vector>
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+#include <string>
+
+struct counted {
+  static int copies;
+  static int moves;
+  static void reset() { copies = moves = 0; }
+  counted(int priority, const std::string& payload = std::string())
+    : priority_m(priority), payload_m(payload) {}
+  counted(const counted& x)
+    : priority_m(x.priority_m), payload_m(x.payload_m) { ++copies; }
+  counted(counted&& x)
+    : priority_m(x.priority_m), payload_m(std::move(x.payload_m)) { ++moves; }
+  counted& operator=(const counted& x) {
+    priority_m = x.priority_m; payload_m = x.payload_m; ++copies; return *this;
+  }
+  counted& operator=(counted&& x) {
+    priority_m = x.priority_m; payload_m = std::move(x.payload_m); ++moves; return *this;
+  }
+  int priority_m;
+  std::string payload_m;
+};
+int counted::copies = 0;
+int counted::moves = 0;
+
+struct move_only {
+  move_only(int priority, int payload)
+    : priority_m(priority), payload_m(new int(payload)) {}
+  move_only(move_only&&) = default;
+  move_only& operator=(move_only&&) = default;
+  int priority_m;
+  std::unique_ptr<int> payload_m;
+};
 
 int main(const int argc, const char** argv) {
   using namespace com_masaers;
@@ -69,6 +102,106 @@ int main(const int argc, const char** argv) {
     }
     cout << endl;
   }
+
+  {
+    auto bh = make_binary_heap<int>();
+    const auto pops_sorted = [&]() -> bool {
+      bool result = true;
+      while (result && ! bh.empty()) {
+	int prev = bh.top();
+	bh.pop();
+	result = bh.empty() || prev <= bh.top();
+      }
+      return result;
+    };
+    vector<int> values;
+    for (int i = 0; i < 100000; ++i) {
+      values.push_back((i * 7919) % 100003);
+    }
+    bh.insert(values.begin(), values.end(), 4);
+    cout << "insert: " << bh.top() << endl;
+    bh.insert(values.begin() + 10, values.begin() + 20, 4);
+    cout << "insert: " << bh.top() << endl;
+    cout << "sorted: " << pops_sorted() << endl;
+    bh.insert(values.begin(), values.end(), 4);
+    for (auto h : bh) {
+      h->value_m = 100003 - h->value_m;
+    }
+    bh.heapify(4);
+    cout << "heapify: " << bh.top() << endl;
+    cout << "sorted: " << pops_sorted() << endl;
+    cout << endl;
+  }
+
+  {
+    auto bh = make_binary_heap<int>();
+    vector<binary_heap<int>::handle_type> handles;
+    for (int i = 0; i < 10; ++i) {
+      handles.push_back(bh.push(i * 3 % 10));
+    }
+    bh.erase(handles[0]);
+    bh.erase(handles[5]);
+    bh.erase(handles[9]);
+    while (! bh.empty()) {
+      cout << ' ' << bh.pop_value();
+    }
+    cout << endl;
+    cout << endl;
+  }
+
+  {
+    auto bh = make_binary_heap<counted>([](counted& x) -> int& { return x.priority_m; }, less<int>());
+    const auto print_counts = [&](const char* what) {
+      cout << what << ": copies=" << counted::copies << " moves=" << counted::moves << endl;
+      counted::reset();
+    };
+    counted::reset();
+    for (int i = 0; i < 10; ++i) {
+      bh.emplace(i * 3 % 10, "request");
+    }
+    print_counts("emplace");
+    bh.push(counted(11, "request"));
+    print_counts("push rvalue");
+    const counted lvalue(12, "request");
+    counted::reset();
+    bh.push(lvalue);
+    print_counts("push lvalue");
+    for (auto h : bh) {
+      bh.update(h, h->value_m.priority_m + 1);
+    }
+    print_counts("update");
+    for (auto h : bh) {
+      bh.ensure_priority(h, h->value_m.priority_m - 1);
+    }
+    print_counts("ensure_priority");
+    bh.pop();
+    print_counts("pop");
+    while (! bh.empty()) {
+      counted x = bh.pop_value();
+      cout << ' ' << x.priority_m << ':' << x.payload_m;
+    }
+    cout << endl;
+    print_counts("pop_value");
+    cout << endl;
+  }
+
+  {
+    auto bh = make_binary_heap<move_only>([](move_only& x) -> int& { return x.priority_m; }, less<int>());
+    for (int i = 0; i < 10; ++i) {
+      bh.push(move_only(i * 7 % 10, i));
+    }
+    move_only x(-1, 100);
+    auto h = bh.push(std::move(x));
+    bh.update(h, 20);
+    bh.ensure_priority(h, 5);
+    bh.emplace(3, 200);
+    while (! bh.empty()) {
+      move_only y = bh.pop_value();
+      cout << ' ' << y.priority_m << ':' << *y.payload_m;
+    }
+    cout << endl;
+    cout << endl;
+  }
   
   return EXIT_SUCCESS;
 }
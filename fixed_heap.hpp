@@ -0,0 +1,249 @@
+#ifndef FIXED_HEAP_HPP
+#define FIXED_HEAP_HPP
+// c++
+#include <array>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+// c
+#include <cstddef>
+#include <cstdint>
+
+
+namespace com_masaers {
+
+  namespace internal {
+    template<std::size_t max_N>
+    struct index_for {
+      typedef typename std::conditional<max_N <= 0xff, std::uint8_t,
+        typename std::conditional<max_N <= 0xffff, std::uint16_t,
+          typename std::conditional<max_N <= 0xffffffff, std::uint32_t,
+            std::size_t>::type>::type>::type type;
+    };
+    // Number of levels in a complete binary tree of n nodes.
+    constexpr std::size_t tree_depth(std::size_t n) {
+      return n == 0 ? 0 : 1 + tree_depth(n / 2);
+    }
+  } // namespace internal
+
+  ///
+  /// A mutable min heap of at most capacity_N values, with the values,
+  /// node positions and the heap itself stored inline so that no
+  /// operation ever allocates. The sift loops are bounded by the
+  /// compile-time depth of the tree, so the compiler can unroll them
+  /// for small capacities. Handles point into the heap object itself
+  /// and are invalidated by copying or moving the heap.
+  ///
+  template<typename value_T,
+	   std::size_t capacity_N,
+	   typename comp_T = std::less<value_T> >
+  class fixed_min_heap {
+  public:
+    typedef typename internal::index_for<capacity_N>::type position_type;
+    typedef typename std::decay<value_T>::type value_type;
+    typedef typename std::decay<comp_T>::type comp_type;
+    static const std::size_t capacity_value = capacity_N;
+    static const std::size_t depth_value = internal::tree_depth(capacity_N);
+    static_assert(capacity_N > 0, "fixed_min_heap needs a positive capacity");
+  protected:
+    struct node_t {
+      typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage_m;
+      position_type position_m;
+      value_type& value() { return *reinterpret_cast<value_type*>(&storage_m); }
+      const value_type& value() const { return *reinterpret_cast<const value_type*>(&storage_m); }
+    }; // node_t
+  public:
+    struct handle_type;
+
+    fixed_min_heap(const comp_T& comp = comp_T())
+      : size_m(0), comp_m(comp)
+    {
+      reset();
+    }
+    fixed_min_heap(const fixed_min_heap& x)
+      : size_m(0), comp_m(x.comp_m)
+    {
+      assign(x);
+    }
+    fixed_min_heap(fixed_min_heap&& x)
+      : size_m(0), comp_m(x.comp_m)
+    {
+      assign(std::move(x));
+    }
+    ~fixed_min_heap() { clear(); }
+    fixed_min_heap& operator=(const fixed_min_heap& x) {
+      if (this != &x) {
+	clear();
+	comp_m = x.comp_m;
+	assign(x);
+      }
+      return *this;
+    }
+    fixed_min_heap& operator=(fixed_min_heap&& x) {
+      if (this != &x) {
+	clear();
+	comp_m = x.comp_m;
+	assign(std::move(x));
+      }
+      return *this;
+    }
+    ///
+    /// Pushes a value, returning its handle, or a default constructed
+    /// handle without touching the heap if it is already full.
+    ///
+    template<typename T> handle_type push(T&& value) {
+      return emplace(std::forward<T>(value));
+    }
+    template<typename... args_T> handle_type emplace(args_T&&... args) {
+      handle_type result;
+      if (! full()) {
+	node_t* node = &nodes_m[heap_m[size_m]];
+	::new (static_cast<void*>(&node->storage_m)) value_type(std::forward<args_T>(args)...);
+	++size_m;
+	bubble_up(node->position_m);
+	result.node_m = node;
+      }
+      return result;
+    }
+    const value_type& top() const {
+      return nodes_m[heap_m[0]].value();
+    }
+    void pop() {
+      erase_at(0);
+    }
+    value_type pop_value() {
+      value_type result(std::move(nodes_m[heap_m[0]].value()));
+      pop();
+      return result;
+    }
+    void erase(handle_type handle) {
+      erase_at(handle.node_m->position_m);
+    }
+    bool empty() const { return size_m == 0; }
+    bool full() const { return size_m == capacity_N; }
+    std::size_t size() const { return size_m; }
+    static constexpr std::size_t capacity() { return capacity_N; }
+    void clear() {
+      for (std::size_t i = 0; i < size_m; ++i) {
+	nodes_m[heap_m[i]].value().~value_type();
+      }
+      size_m = 0;
+    }
+    bool maintain_towards_top(handle_type handle) {
+      return bubble_up(handle.node_m->position_m);
+    }
+    bool maintain_towards_bottom(handle_type handle) {
+      return bubble_down(handle.node_m->position_m);
+    }
+    bool maintain_update(handle_type handle) {
+      return bubble_up(handle.node_m->position_m)
+	|| bubble_down(handle.node_m->position_m);
+    }
+  protected:
+    // heap_m is a permutation of all node indices: the first size_m
+    // are the heap, the rest are the free nodes.
+    void reset() {
+      for (std::size_t i = 0; i < capacity_N; ++i) {
+	heap_m[i] = position_type(i);
+	nodes_m[i].position_m = position_type(i);
+      }
+    }
+    template<typename heap_T>
+    void assign(heap_T&& x) {
+      heap_m = x.heap_m;
+      for (std::size_t i = 0; i < capacity_N; ++i) {
+	nodes_m[i].position_m = x.nodes_m[i].position_m;
+      }
+      for (; size_m < x.size_m; ++size_m) {
+	typedef typename std::conditional<std::is_lvalue_reference<heap_T>::value, const value_type&, value_type&&>::type ref_type;
+	::new (static_cast<void*>(&nodes_m[heap_m[size_m]].storage_m))
+	  value_type(static_cast<ref_type>(x.nodes_m[heap_m[size_m]].value()));
+      }
+    }
+    void erase_at(std::size_t position) {
+      --size_m;
+      swap_positions(position, size_m);
+      nodes_m[heap_m[size_m]].value().~value_type();
+      if (position < size_m) {
+	bubble_up(position) || bubble_down(position);
+      }
+    }
+    bool less_at(std::size_t a, std::size_t b) const {
+      return comp_m(nodes_m[heap_m[a]].value(), nodes_m[heap_m[b]].value());
+    }
+    void swap_positions(std::size_t a, std::size_t b) {
+      using std::swap;
+      swap(heap_m[a], heap_m[b]);
+      nodes_m[heap_m[a]].position_m = position_type(a);
+      nodes_m[heap_m[b]].position_m = position_type(b);
+    }
+    // Both sift loops take at most one step per level of the tree.
+    bool bubble_up(std::size_t position) {
+      bool result = false;
+      for (std::size_t d = 1; d < depth_value; ++d) {
+	const std::size_t parent = (position - 1) / 2;
+	if (position == 0 || ! less_at(position, parent)) {
+	  break;
+	}
+	swap_positions(position, parent);
+	position = parent;
+	result = true;
+      }
+      return result;
+    }
+    bool bubble_down(std::size_t position) {
+      bool result = false;
+      for (std::size_t d = 1; d < depth_value; ++d) {
+	std::size_t child = (position * 2) + 1;
+	if (child >= size_m) {
+	  break;
+	}
+	if (child + 1 < size_m && less_at(child + 1, child)) {
+	  ++child;
+	}
+	if (! less_at(child, position)) {
+	  break;
+	}
+	swap_positions(position, child);
+	position = child;
+	result = true;
+      }
+      return result;
+    }
+    std::array<node_t, capacity_N> nodes_m;
+    std::array<position_type, capacity_N> heap_m;
+    std::size_t size_m;
+    comp_type comp_m;
+  }; // fixed_min_heap
+
+
+  template<typename value_T,
+	   std::size_t capacity_N,
+	   typename comp_T>
+  struct fixed_min_heap<value_T, capacity_N, comp_T>::handle_type {
+    friend class fixed_min_heap;
+    handle_type() : node_m(NULL) {}
+    value_type& operator*() const { return node_m->value(); }
+    value_type* operator->() const { return &node_m->value(); }
+    bool operator==(const handle_type& x) const { return node_m == x.node_m; }
+    bool operator!=(const handle_type& x) const { return node_m != x.node_m; }
+    value_type& value() const { return node_m->value(); }
+  protected:
+    node_t* node_m;
+  }; // handle_type
+
+
+  template<typename value_T,
+	   std::size_t capacity_N,
+	   typename comp_T = std::less<value_T> >
+  fixed_min_heap<value_T, capacity_N, typename std::decay<comp_T>::type>
+  make_fixed_min_heap(comp_T&& comp = comp_T()) {
+    return fixed_min_heap<value_T, capacity_N, typename std::decay<comp_T>::type>(std::forward<comp_T>(comp));
+  }
+
+} // namespace com_masaers
+
+
+/******************************************************************************/
+#endif
@@ -0,0 +1,151 @@
+#include "fixed_heap.hpp"
+#include "mutable_heap.hpp"
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define _TEST_OUTPUT_PREFIX(stream)		\
+  stream << __FILE__ << ":" << __LINE__ << " "; \
+  
+#define TEST(expr)                                                      \
+  try {									\
+    if (expr) {                                                         \
+      _TEST_OUTPUT_PREFIX(std::cout);                                   \
+      std::cout << #expr << " [PASSED]" << std::endl;                   \
+    } else {								\
+      _TEST_OUTPUT_PREFIX(std::cerr);					\
+      std::cerr << #expr << " [FAILED]" << std::endl;			\
+    }									\
+  } catch (const std::exception& e) {					\
+    _TEST_OUTPUT_PREFIX(std::cerr);                                     \
+    std::cerr << #expr;							\
+      std::cerr << " exception: \"" << e.what() << "\"";                \
+      std::cerr << " [FAILED]" << std::endl;                            \
+  } catch (...) {							\
+    _TEST_OUTPUT_PREFIX(std::cerr);                                     \
+    std::cerr << #expr << " unknown exception [FAILED]" << std::endl;	\
+  }									\
+  
+#define TEST_INFO(...)						       \
+  _TEST_OUTPUT_PREFIX(std::cout);				       \
+  std::cout << #__VA_ARGS__ << " [EXECUTING]" << std::endl;	       \
+  __VA_ARGS__;							       \
+  
+
+template<typename heap_T>
+void test_fixed_min_heap(heap_T&& h, const char* name) {
+  using namespace std;
+  typedef typename std::decay<heap_T>::type heap_type;
+
+  TEST(h.empty());
+  TEST(h.capacity() == 4);
+  TEST_INFO(auto x1 = h.push(1));
+  TEST_INFO(auto x2 = h.push(2));
+  TEST_INFO(auto x10 = h.push(10));
+  TEST_INFO(auto x5 = h.push(5));
+  TEST(h.full());
+  TEST(h.push(0) == typename heap_type::handle_type());
+  TEST(h.size() == 4);
+  TEST(h.top() == 1);
+  TEST_INFO(*x10 = 0);
+  TEST_INFO(h.maintain_towards_top(x10));
+  TEST(h.top() == 0);
+  TEST_INFO(*x10 = 10);
+  TEST_INFO(h.maintain_towards_bottom(x10));
+  TEST(h.top() == 1);
+  TEST_INFO(h.erase(x1));
+  TEST(h.top() == 2);
+  TEST_INFO(*x5 = 0);
+  TEST_INFO(h.maintain_update(x5));
+  TEST(h.top() == 0);
+  TEST_INFO(h.erase(x2));
+  TEST(h.size() == 2);
+  TEST_INFO(heap_type copy(h));
+  TEST(copy.pop_value() == 0);
+  TEST(copy.pop_value() == 10);
+  TEST(copy.empty());
+  TEST(h.size() == 2);
+  TEST_INFO(h.push(7));
+  TEST_INFO(h.pop());
+  TEST(h.top() == 7);
+  TEST_INFO(h.pop());
+  TEST(h.top() == 10);
+  TEST_INFO(h.clear());
+  TEST(h.empty());
+}
+
+// Runs the same random push/pop/update/erase trace on a fixed heap
+// and a mutable heap and checks that their tops agree throughout.
+bool same_as_mutable_heap(unsigned int seed) {
+  using namespace std;
+  using namespace com_masaers;
+  auto f = make_fixed_min_heap<int, 100>();
+  auto m = make_mutable_min_heap<int>();
+  vector<pair<decltype(f.push(0)), decltype(m.push(0))> > handles;
+  mt19937 rng(seed);
+  bool result = true;
+  for (int op = 0; result && op < 100000; ++op) {
+    const unsigned int kind = rng() % 4;
+    if (kind == 0 && ! handles.empty()) {
+      const size_t i = rng() % handles.size();
+      f.erase(handles[i].first);
+      m.erase(handles[i].second);
+      handles[i] = handles.back();
+      handles.pop_back();
+    } else if (kind == 1 && ! handles.empty()) {
+      const size_t i = rng() % handles.size();
+      const int value = int(rng() % 1000);
+      *handles[i].first = value;
+      *handles[i].second = value;
+      f.maintain_update(handles[i].first);
+      m.maintain_update(handles[i].second);
+    } else if (! f.full()) {
+      const int value = int(rng() % 1000);
+      handles.push_back(make_pair(f.push(value), m.push(value)));
+    }
+    result = f.size() == m.size() && (f.empty() || f.top() == m.top());
+  }
+  while (result && ! f.empty()) {
+    result = f.pop_value() == m.top();
+    m.pop();
+  }
+  return result && m.empty();
+}
+
+
+int main(const int argc, const char** argv) {
+  using namespace std;
+  using namespace com_masaers;
+
+  test_fixed_min_heap(make_fixed_min_heap<int, 4>(),
+		      "make_fixed_min_heap<T, 4>()");
+  test_fixed_min_heap(make_fixed_min_heap<int, 4>(less<int>()),
+		      "make_fixed_min_heap<T, 4>(less<T>())");
+  TEST(same_as_mutable_heap(1));
+  TEST(same_as_mutable_heap(2));
+
+  {
+    typedef unique_ptr<int> ptr;
+    const auto ptr_less = [](const ptr& a, const ptr& b) { return *a < *b; };
+    TEST_INFO(auto h = make_fixed_min_heap<ptr, 3>(ptr_less));
+    TEST_INFO(h.push(ptr(new int(3))));
+    TEST_INFO(h.emplace(new int(1)));
+    TEST_INFO(h.push(ptr(new int(2))));
+    TEST(h.push(ptr(new int(0))) == decltype(h.push(ptr()))());
+    TEST(*h.pop_value() == 1);
+    TEST(*h.pop_value() == 2);
+    TEST(*h.pop_value() == 3);
+  }
+
+  {
+    TEST_INFO(auto h = make_fixed_min_heap<int, 1>());
+    TEST(h.push(2) != decltype(h.push(2))());
+    TEST(h.push(1) == decltype(h.push(1))());
+    TEST(h.top() == 2);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/******************************************************************************/
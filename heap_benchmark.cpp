@@ -0,0 +1,240 @@
+#include "binary_heap.hpp"
+#include "fixed_heap.hpp"
+#include "mutable_heap.hpp"
+#include "timer_wheel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+  template<typename func_T>
+  double seconds(func_T&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  std::vector<unsigned int> thread_counts() {
+    std::vector<unsigned int> result;
+    const unsigned int max = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 1; t < max; t *= 2) {
+      result.push_back(t);
+    }
+    result.push_back(max);
+    return result;
+  }
+
+  ///
+  /// Times bulk construction, batch insertion into a half full heap
+  /// and rebuilding after changing every priority, for each thread
+  /// count, and reports the speedup over a single thread.
+  ///
+  template<typename make_T, typename mutate_T>
+  void bench_parallel(const char* name, const std::vector<int>& values,
+		      make_T&& make_heap, mutate_T&& mutate) {
+    using namespace std;
+    const auto half = values.begin() + values.size() / 2;
+    double base_build = 0, base_insert = 0, base_heapify = 0;
+    {
+      auto h = make_heap();
+      const double push_loop = seconds([&]() {
+	  for (auto it = values.begin(); it != values.end(); ++it) {
+	    h.push(*it);
+	  }
+	});
+      cout << name << " push loop: " << push_loop << " s" << endl;
+    }
+    for (unsigned int threads : thread_counts()) {
+      auto h = make_heap();
+      const double build = seconds([&]() { h.insert(values.begin(), values.end(), threads); });
+      for (auto it = h.begin(); it != h.end(); ++it) {
+	mutate(*it);
+      }
+      const double heapify = seconds([&]() { h.heapify(threads); });
+      auto g = make_heap();
+      g.insert(values.begin(), half, threads);
+      const double insert = seconds([&]() { g.insert(half, values.end(), threads); });
+      if (threads == 1) {
+	base_build = build;
+	base_insert = insert;
+	base_heapify = heapify;
+      }
+      cout << name << " threads=" << setw(3) << threads
+	   << " build: " << build << " s (x" << base_build / build << ")"
+	   << " insert: " << insert << " s (x" << base_insert / insert << ")"
+	   << " heapify: " << heapify << " s (x" << base_heapify / heapify << ")"
+	   << endl;
+    }
+  }
+
+  struct timer {
+    std::uint64_t time;
+    std::size_t id;
+  };
+
+  struct timer_time {
+    const std::uint64_t& operator()(const timer& x) const { return x.time; }
+  };
+
+  struct timer_less {
+    bool operator()(const timer& a, const timer& b) const { return a.time < b.time; }
+  };
+
+  template<typename heap_T, typename func_T>
+  void expire(heap_T& heap, std::uint64_t now, func_T&& func) {
+    while (! heap.empty() && heap.top().time <= now) {
+      const std::size_t id = heap.top().id;
+      heap.pop();
+      func(id);
+    }
+  }
+
+  template<typename value_T, typename time_ex_T, std::size_t levels_N, typename func_T>
+  void expire(com_masaers::timer_wheel<value_T, time_ex_T, levels_N>& wheel,
+	      std::uint64_t now, func_T&& func) {
+    wheel.advance(now);
+    while (wheel.expired()) {
+      const std::size_t id = wheel.top().id;
+      wheel.pop();
+      func(id);
+    }
+  }
+
+  ///
+  /// Replays a timer churn trace: n live timers with 1 ms ticks, where
+  /// each operation cancels and re-arms a timer, reschedules one, or
+  /// advances the clock and re-arms everything that fired.
+  ///
+  template<typename make_T>
+  void bench_timers(const char* name, std::size_t n, std::size_t ops, make_T&& make_timers) {
+    using namespace std;
+    auto timers = make_timers();
+    vector<decltype(timers.push(timer()))> handles;
+    mt19937_64 rng(4711);
+    uint64_t now = 0;
+    const auto deadline = [&]() -> uint64_t {
+      // Mostly short timeouts, some up to a day
+      return now + 1 + (rng() % 100 == 0 ? rng() % 86400000 : rng() % 30000);
+    };
+    for (size_t id = 0; id < n; ++id) {
+      const timer t = { deadline(), id };
+      handles.push_back(timers.push(t));
+    }
+    size_t fired = 0;
+    vector<size_t> expired;
+    const double elapsed = seconds([&]() {
+	for (size_t op = 0; op < ops; ++op) {
+	  const size_t id = rng() % n;
+	  const unsigned int kind = rng() % 16;
+	  if (kind < 7) {
+	    timers.erase(handles[id]);
+	    const timer t = { deadline(), id };
+	    handles[id] = timers.push(t);
+	  } else if (kind < 15) {
+	    handles[id]->time = deadline();
+	    timers.maintain_update(handles[id]);
+	  } else {
+	    now += 1;
+	    // Re-arm in id order so that both containers replay the
+	    // same trace even though the wheel fires in any order
+	    expired.clear();
+	    expire(timers, now, [&](size_t id) { expired.push_back(id); });
+	    sort(expired.begin(), expired.end());
+	    for (auto it = expired.begin(); it != expired.end(); ++it) {
+	      const timer t = { deadline(), *it };
+	      handles[*it] = timers.push(t);
+	    }
+	    fired += expired.size();
+	  }
+	}
+      });
+    cout << name << " timers=" << n << " ops=" << ops
+	 << ": " << elapsed << " s (" << elapsed / ops * 1e9 << " ns/op, "
+	 << fired << " fired)" << endl;
+  }
+
+  ///
+  /// Measures the latency of single push and pop operations on a heap
+  /// kept around 48 elements, and reports the p50 and p99 per op. The
+  /// numbers include the overhead of reading the clock.
+  ///
+  template<typename make_T>
+  void bench_latency(const char* name, std::size_t ops, make_T&& make_heap) {
+    using namespace std;
+    typedef chrono::steady_clock clock;
+    auto h = make_heap();
+    mt19937 rng(4711);
+    vector<double> push_ns, pop_ns;
+    push_ns.reserve(ops);
+    pop_ns.reserve(ops);
+    for (size_t i = 0; i < 48; ++i) {
+      h.push(int(rng() >> 1));
+    }
+    for (size_t op = 0; op < ops; ++op) {
+      const int value = int(rng() >> 1);
+      const auto t0 = clock::now();
+      h.push(value);
+      const auto t1 = clock::now();
+      h.pop();
+      const auto t2 = clock::now();
+      push_ns.push_back(chrono::duration<double, nano>(t1 - t0).count());
+      pop_ns.push_back(chrono::duration<double, nano>(t2 - t1).count());
+    }
+    const auto percentile = [](vector<double>& x, double p) {
+      auto it = x.begin() + size_t(p * (x.size() - 1));
+      nth_element(x.begin(), it, x.end());
+      return *it;
+    };
+    cout << name
+	 << " push p50: " << percentile(push_ns, 0.5) << " ns"
+	 << " p99: " << percentile(push_ns, 0.99) << " ns"
+	 << " pop p50: " << percentile(pop_ns, 0.5) << " ns"
+	 << " p99: " << percentile(pop_ns, 0.99) << " ns" << endl;
+  }
+
+} // namespace
+
+int main(const int argc, const char** argv) {
+  using namespace std;
+  using namespace com_masaers;
+
+  const size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+  vector<int> values(n);
+  mt19937 rng(4711);
+  for (auto& x : values) {
+    x = int(rng() >> 1);
+  }
+
+  cout << "elements: " << n << endl;
+  bench_parallel("binary_heap", values,
+		 []() { return make_binary_heap<int>(); },
+		 [](binary_heap<int>::handle_type h) { h->value_m = ~h->value_m; });
+  bench_parallel("mutable_min_heap", values,
+		 []() { return make_mutable_min_heap<int>(); },
+		 [](mutable_min_heap<int>::handle_type h) { *h = ~*h; });
+
+  for (size_t timers : { size_t(10000), size_t(1000000) }) {
+    bench_timers("mutable_min_heap", timers, 1000000,
+		 []() { return make_mutable_min_heap<timer>(timer_less()); });
+    bench_timers("timer_wheel", timers, 1000000,
+		 []() { return make_timer_wheel<timer>(0, timer_time()); });
+  }
+
+  bench_latency("binary_heap", 1000000,
+		[]() { return make_binary_heap<int>(); });
+  bench_latency("mutable_min_heap", 1000000,
+		[]() { return make_mutable_min_heap<int>(); });
+  bench_latency("fixed_min_heap<64>", 1000000,
+		[]() { return make_fixed_min_heap<int, 64>(); });
+
+  return EXIT_SUCCESS;
+}
@@ -4,6 +4,9 @@
 #include <functional>
 #include <vector>
 // c
+#include <cstddef>
+// local
+#include "parallel.hpp"
 
 
 namespace com_masaers {
@@ -54,6 +57,46 @@ namespace com_masaers {
       bubble_up(result);
       return result;
     }
+    ///
+    /// Pushes all values in [first, last) as one batch. The nodes are
+    /// constructed concurrently on up to threads threads (zero means
+    /// one per hardware thread) and then merged in by a parallel
+    /// bottom-up heapify of the affected subtrees. Pushing a batch into
+    /// an empty heap is a parallel bulk construction.
+    ///
+    template<typename RandomIt>
+    void insert(RandomIt first, RandomIt last, unsigned int threads = 0) {
+      const position_type old_size = container_m.size();
+      container_m.resize(old_size + (last - first));
+      try {
+	internal::parallel_for(old_size, container_m.size(), threads, 1 << 10,
+			       [&](position_type position) {
+				 container_m[position] = handle_type(new node_t(first[position - old_size], position));
+			       });
+      } catch (...) {
+	for (position_type position = old_size; position < container_m.size(); ++position) {
+	  container_m[position].clear();
+	}
+	container_m.resize(old_size);
+	throw;
+      }
+      internal::parallel_heapify(container_m.size(), old_size, threads,
+				 [&](position_type position) {
+				   bubble_down(container_m[position]);
+				 });
+    }
+    ///
+    /// Restores the heap property of the entire heap, for use after
+    /// many values have been changed in place through their
+    /// handles. Independent subtrees are heapified concurrently on up
+    /// to threads threads.
+    ///
+    void heapify(unsigned int threads = 0) {
+      internal::parallel_heapify(container_m.size(), 0, threads,
+				 [&](position_type position) {
+				   bubble_down(container_m[position]);
+				 });
+    }
     const value_type& top() const {
       return container_m.front().value();
     }
@@ -98,10 +141,10 @@ namespace com_masaers {
     }
     void erase(handle_type handle) {
       handle_type replacement(container_m.back());
-      swap_nodes(handle, replacement);
+      swap_handles(handle, replacement);
       container_m.back().clear();
       container_m.pop_back();
-      if (! container_m.empty()) {
+      if (replacement != handle) {
 	maintain_update(replacement);
       }
     }
@@ -1,5 +1,7 @@
 #include "mutable_heap.hpp"
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 #define _TEST_OUTPUT_PREFIX(stream)		\
   stream << __FILE__ << ":" << __LINE__ << " "; \
@@ -119,6 +121,42 @@ void test_mutable_min_heap(heap_T&& h, const char* name) {
   TEST(h.top() == *x5);
 }
 
+template<typename heap_T>
+bool pops_sorted(heap_T& h) {
+  bool result = true;
+  while (result && ! h.empty()) {
+    auto prev = h.top();
+    h.pop();
+    result = h.empty() || ! (h.top() < prev);
+  }
+  return result;
+}
+
+template<typename heap_T>
+void test_batch_heap(heap_T&& h, const char* name) {
+  using namespace std;
+
+  TEST_INFO(vector<int> values);
+  TEST_INFO(for (int i = 0; i < 100000; ++i) values.push_back((i * 7919) % 100003));
+  TEST_INFO(h.insert(values.begin(), values.end(), 4));
+  TEST(h.size() == 100000);
+  TEST(h.top() == 0);
+  TEST_INFO(h.insert(values.begin(), values.begin() + 5000, 4));
+  TEST(h.size() == 105000);
+  TEST_INFO(h.push(-1));
+  TEST_INFO(h.insert(values.begin(), values.begin() + 3, 4));
+  TEST(h.top() == -1);
+  TEST(pops_sorted(h));
+  TEST_INFO(h.insert(values.begin(), values.end(), 4));
+  TEST_INFO(for (auto& x : h) *x = 100003 - *x);
+  TEST_INFO(h.heapify(4));
+  TEST(h.top() == 100003 - *max_element(values.begin(), values.end()));
+  TEST(pops_sorted(h));
+  TEST_INFO(h.insert(values.begin(), values.begin() + 10, 1));
+  TEST(h.top() == 0);
+  TEST(pops_sorted(h));
+}
+
 
 int main(const int argc, const char** argv) {
   using namespace std;
@@ -150,6 +188,9 @@ int main(const int argc, const char** argv) {
   test_mutable_min_heap(make_mutable_min_heap<int, vector>(less<int>()),
 			"make_mutable_min_heap<T, vector>(less<T>())");
 
+  test_batch_heap(make_mutable_min_heap<int>(),
+		  "make_mutable_min_heap<T>()");
+
   return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,146 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+// c++
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+// c
+#include <cstddef>
+
+
+namespace com_masaers {
+  namespace internal {
+
+    ///
+    /// Resolves a requested thread count, where zero means "as many
+    /// as the hardware supports".
+    ///
+    inline unsigned int thread_count(unsigned int threads) {
+      if (threads == 0) {
+	threads = std::thread::hardware_concurrency();
+      }
+      return threads == 0 ? 1 : threads;
+    }
+
+    ///
+    /// Calls func(i) for every i in [first, last), splitting the range
+    /// into contiguous chunks over at most threads threads. Chunks are
+    /// never smaller than grain, so small ranges run on the calling
+    /// thread without spawning anything. If a thread cannot be started,
+    /// its chunk and all later ones run on the calling thread instead.
+    /// The first exception thrown by func is rethrown once all threads
+    /// have been joined.
+    ///
+    template<typename func_T>
+    void parallel_for(std::size_t first, std::size_t last,
+		      unsigned int threads, std::size_t grain,
+		      func_T&& func) {
+      const std::size_t size = last > first ? last - first : 0;
+      std::size_t chunks = std::min<std::size_t>(thread_count(threads),
+						 size / std::max<std::size_t>(grain, 1));
+      if (chunks <= 1) {
+	for (std::size_t i = first; i < last; ++i) {
+	  func(i);
+	}
+	return;
+      }
+      std::exception_ptr error;
+      std::mutex error_mutex;
+      const auto run = [&](std::size_t begin, std::size_t end) {
+	try {
+	  for (std::size_t i = begin; i < end; ++i) {
+	    func(i);
+	  }
+	} catch (...) {
+	  std::lock_guard<std::mutex> lock(error_mutex);
+	  if (! error) {
+	    error = std::current_exception();
+	  }
+	}
+      };
+      std::vector<std::thread> workers;
+      bool serial = false;
+      try {
+	workers.reserve(chunks - 1);
+      } catch (...) {
+	serial = true;
+      }
+      std::size_t begin = first;
+      for (std::size_t c = 0; c < chunks; ++c) {
+	const std::size_t end = begin + size / chunks + (c < size % chunks ? 1 : 0);
+	if (! serial && c + 1 < chunks) {
+	  try {
+	    workers.emplace_back(run, begin, end);
+	  } catch (...) {
+	    // Out of threads; fall back to doing the rest ourselves.
+	    serial = true;
+	  }
+	}
+	if (serial || c + 1 == chunks) {
+	  run(begin, end);
+	}
+	begin = end;
+      }
+      for (auto it = workers.begin(); it != workers.end(); ++it) {
+	it->join();
+      }
+      if (error) {
+	std::rethrow_exception(error);
+      }
+    }
+
+    ///
+    /// Restores the heap property of an implicit binary heap of the
+    /// given size where every position before first_dirty already
+    /// satisfied it, by calling sift_down(position) on every internal
+    /// node that has a dirty descendant. Nodes are visited bottom-up
+    /// one depth at a time; nodes at the same depth root disjoint
+    /// subtrees, so each depth is sifted in parallel. With first_dirty
+    /// at zero this is Floyd's heap construction.
+    ///
+    template<typename sift_T>
+    void parallel_heapify(std::size_t size, std::size_t first_dirty,
+			  unsigned int threads, sift_T&& sift_down) {
+      static const std::size_t grain = 1 << 12;
+      if (size < 2 || first_dirty >= size) {
+	return;
+      }
+      // depth(n) = floor(log2(n + 1)), level d spans [2^d - 1, 2^(d+1) - 1)
+      const auto depth = [](std::size_t position) -> std::size_t {
+	std::size_t result = 0;
+	for (++position; position > 1; position >>= 1) {
+	  ++result;
+	}
+	return result;
+      };
+      const auto ancestor = [](std::size_t position, std::size_t up) {
+	for (; up > 0; --up) {
+	  position = (position - 1) / 2;
+	}
+	return position;
+      };
+      const std::size_t last_parent = (size - 2) / 2;
+      const std::size_t dirty_depth = depth(first_dirty);
+      const std::size_t bottom_depth = depth(size - 1);
+      for (std::size_t d = depth(last_parent) + 1; d-- > 0; ) {
+	const std::size_t level_begin = (std::size_t(1) << d) - 1;
+	const std::size_t level_end = std::min(2 * level_begin, last_parent);
+	// The leftmost dirty node at depth d is the ancestor of the
+	// leftmost dirty position on one of the deeper levels.
+	std::size_t lo = level_end + 1;
+	for (std::size_t e = std::max(d, dirty_depth); e <= bottom_depth; ++e) {
+	  const std::size_t start = std::max(first_dirty, (std::size_t(1) << e) - 1);
+	  lo = std::min(lo, ancestor(start, e - d));
+	}
+	parallel_for(lo, level_end + 1, threads, grain, sift_down);
+      }
+    }
+
+  } // namespace internal
+} // namespace com_masaers
+
+
+/******************************************************************************/
+#endif
@@ -0,0 +1,403 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+// c++
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+// c
+#include <cstddef>
+#include <cstdint>
+// local
+#include "binary_heap.hpp"
+
+
+namespace com_masaers {
+
+  ///
+  /// A hierarchical timing wheel over values with unsigned integer
+  /// timestamps, offering the handle API of mutable_min_heap with
+  /// O(1) push, erase and maintain_update.
+  ///
+  /// Each of the levels_N levels has 64 slots, and a slot on level i
+  /// spans 64^i ticks. A timer sits on the lowest level where its
+  /// deadline shares all higher digits with the wheel's clock, and is
+  /// cascaded one or more levels down when the clock reaches its
+  /// slot. Deadlines beyond the last level are kept in an overflow
+  /// binary_heap until the clock comes within range.
+  ///
+  /// The clock only moves through advance(), and never backwards.
+  /// Timers at or before the clock are due, and top() and pop() return
+  /// due timers first, in no particular order among themselves. When
+  /// nothing is due they return the timer with the earliest deadline.
+  /// Finding it takes a scan of its slot if that is above the lowest
+  /// level, but the result is cached until that timer is removed or
+  /// rescheduled, so repeated calls are O(1).
+  ///
+  template<typename value_T,
+	   typename time_ex_T = internal::id_func,
+	   std::size_t levels_N = 4>
+  class timer_wheel {
+  public:
+    typedef typename std::decay<value_T>::type value_type;
+    typedef typename std::decay<time_ex_T>::type time_ex_type;
+    typedef typename std::decay<decltype(std::declval<const time_ex_type&>()(std::declval<value_type&>()))>::type time_type;
+    static const std::size_t slot_bits = 6;
+    static const std::size_t slots = std::size_t(1) << slot_bits;
+    static const std::size_t levels = levels_N;
+    static_assert(std::is_integral<time_type>::value && std::is_unsigned<time_type>::value,
+		  "timer_wheel needs unsigned integer timestamps");
+    static_assert(levels > 0 && slot_bits * levels < std::numeric_limits<time_type>::digits,
+		  "timer_wheel levels must leave room for the overflow heap");
+  protected:
+    struct node_t;
+    struct overflow_time_ex {
+      time_type& operator()(node_t* const& node) const { return node->time_m; }
+    };
+    typedef binary_heap<node_t*, overflow_time_ex, std::less<time_type> > overflow_type;
+  public:
+    struct handle_type;
+
+    timer_wheel(time_type now = 0, const time_ex_T& time_ex = time_ex_T())
+      : buckets_m(levels * slots + 1, NULL), occupied_m(), overflow_m(),
+	now_m(now), size_m(0), time_ex_m(time_ex), earliest_m(NULL)
+    {
+      occupied_m.fill(0);
+    }
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel(timer_wheel&& x)
+      : buckets_m(std::move(x.buckets_m)), occupied_m(x.occupied_m),
+	overflow_m(std::move(x.overflow_m)), now_m(x.now_m), size_m(x.size_m),
+	time_ex_m(std::move(x.time_ex_m)), earliest_m(x.earliest_m)
+    {
+      // The list heads moved along with the vector's buffer; leave the
+      // source as a valid empty wheel.
+      x.buckets_m.assign(levels * slots + 1, NULL);
+      x.occupied_m.fill(0);
+      x.size_m = 0;
+      x.earliest_m = NULL;
+    }
+    ~timer_wheel() { clear(); }
+    template<typename T> handle_type push(T&& value) {
+      return emplace(std::forward<T>(value));
+    }
+    template<typename... args_T> handle_type emplace(args_T&&... args) {
+      node_t* node = new node_t(std::forward<args_T>(args)...);
+      node->time_m = time_ex_m(node->value_m);
+      place(node);
+      ++size_m;
+      return handle_type(node);
+    }
+    ///
+    /// A due timer if there is one, otherwise the timer with the
+    /// earliest deadline. The clock is left where it is.
+    ///
+    const value_type& top() const {
+      return earliest()->value_m;
+    }
+    /// The deadline of top(), which is at or before now() if it is due.
+    time_type next_deadline() const {
+      return earliest()->time_m;
+    }
+    void pop() {
+      node_t* node = earliest();
+      detach(node);
+      delete node;
+      --size_m;
+    }
+    void erase(handle_type handle) {
+      detach(handle.node_m);
+      delete handle.node_m;
+      --size_m;
+    }
+    bool empty() const { return size_m == 0; }
+    std::size_t size() const { return size_m; }
+    void clear() {
+      for (auto it = buckets_m.begin(); it != buckets_m.end(); ++it) {
+	while (*it != NULL) {
+	  node_t* node = *it;
+	  unlink(node);
+	  delete node;
+	}
+      }
+      for (auto it = overflow_m.begin(); it != overflow_m.end(); ++it) {
+	delete (*it)->value_m;
+      }
+      overflow_m.clear();
+      occupied_m.fill(0);
+      size_m = 0;
+      earliest_m = NULL;
+    }
+    // The maintain functions return whether the timer moved to another
+    // slot or level, including into or out of the overflow heap.
+    bool maintain_towards_top(handle_type handle) {
+      return maintain_update(handle);
+    }
+    bool maintain_towards_bottom(handle_type handle) {
+      return maintain_update(handle);
+    }
+    ///
+    /// Reschedules a timer after its value has been changed through
+    /// its handle. O(1) unless the timer enters or leaves the overflow
+    /// heap.
+    ///
+    bool maintain_update(handle_type handle) {
+      node_t* node = handle.node_m;
+      const std::size_t bucket = node->bucket_m;
+      const time_type time = time_ex_m(node->value_m);
+      if (node->overflow_m != NULL && time > now_m && level_of(time) == levels) {
+	forget(node);
+	overflow_m.update(node->overflow_m, time);
+	remember(node);
+      } else {
+	detach(node);
+	node->time_m = time;
+	place(node);
+      }
+      return node->bucket_m != bucket;
+    }
+    ///
+    /// Moves the clock forward to time, cascading every slot it passes,
+    /// so that exactly the timers at or before time are due.
+    ///
+    void advance(time_type time) {
+      while (step(time)) {}
+      if (now_m < time) {
+	now_m = time;
+      }
+    }
+    /// True if some timer is at or before the clock.
+    bool expired() const { return due() != NULL; }
+    time_type now() const { return now_m; }
+  protected:
+    // Intrusive lists threaded through the nodes; pprev_m points at
+    // whichever pointer points at the node, so unlinking needs no
+    // knowledge of the bucket. The bucket heads live in a vector so
+    // that their addresses survive moving the wheel.
+    static void link(node_t*& head, node_t* node) {
+      node->next_m = head;
+      node->pprev_m = &head;
+      if (head != NULL) {
+	head->pprev_m = &node->next_m;
+      }
+      head = node;
+    }
+    static void unlink(node_t* node) {
+      *node->pprev_m = node->next_m;
+      if (node->next_m != NULL) {
+	node->next_m->pprev_m = node->pprev_m;
+      }
+    }
+    node_t*& due() { return buckets_m.back(); }
+    node_t* due() const { return buckets_m.back(); }
+    node_t*& bucket(std::size_t level, std::size_t slot) {
+      return buckets_m[level * slots + slot];
+    }
+    node_t* bucket(std::size_t level, std::size_t slot) const {
+      return buckets_m[level * slots + slot];
+    }
+    static time_type digit(time_type time, std::size_t level) {
+      return (time >> (slot_bits * level)) & (slots - 1);
+    }
+    // The lowest level on which time shares all higher digits with
+    // the clock, or levels if it belongs in the overflow heap.
+    std::size_t level_of(time_type time) const {
+      const time_type diff = time ^ now_m;
+      std::size_t result = 0;
+      while (result < levels && (diff >> (slot_bits * (result + 1))) != 0) {
+	++result;
+      }
+      return result;
+    }
+    void place(node_t* node) {
+      if (node->time_m <= now_m) {
+	link(due(), node);
+	node->bucket_m = levels * slots;
+      } else {
+	const std::size_t level = level_of(node->time_m);
+	if (level < levels) {
+	  const std::size_t slot = digit(node->time_m, level);
+	  link(bucket(level, slot), node);
+	  node->bucket_m = level * slots + slot;
+	  occupied_m[level] |= std::uint64_t(1) << slot;
+	} else {
+	  node->overflow_m = overflow_m.push(node);
+	  node->bucket_m = levels * slots + 1;
+	}
+	remember(node);
+      }
+    }
+    void detach(node_t* node) {
+      forget(node);
+      if (node->overflow_m != NULL) {
+	overflow_m.erase(node->overflow_m);
+	node->overflow_m = NULL;
+      } else {
+	unlink(node);
+      }
+    }
+    // The first occupied slot after the clock's digit on a level, or
+    // slots if there is none. Slots at or before the clock's digit are
+    // empty, but their occupancy bits are only cleared lazily.
+    std::size_t first_slot(std::size_t level) const {
+      std::uint64_t bits = occupied_m[level] & ~((std::uint64_t(2) << digit(now_m, level)) - 1);
+      while (bits != 0 && bucket(level, lowest_bit(bits)) == NULL) {
+	bits &= bits - 1;
+      }
+      return bits == 0 ? slots : lowest_bit(bits);
+    }
+    // earliest_m caches the pending timer with the earliest deadline,
+    // or is NULL when unknown. A timer placed before it replaces it,
+    // and removing it clears the cache; cascading never changes a
+    // deadline, so it stays valid while the clock advances.
+    void remember(node_t* node) {
+      if (earliest_m != NULL && node->time_m < earliest_m->time_m) {
+	earliest_m = node;
+      }
+    }
+    void forget(node_t* node) {
+      if (node == earliest_m) {
+	earliest_m = NULL;
+      }
+    }
+    // Every timer on a level is later than all timers on the levels
+    // below, so the earliest one is in the first occupied slot of the
+    // lowest occupied level. Only level 0 slots hold a single deadline.
+    node_t* earliest() const {
+      if (due() != NULL) {
+	return due();
+      }
+      if (earliest_m == NULL) {
+	earliest_m = overflow_m.empty() ? NULL : overflow_m.top();
+	for (std::size_t level = 0; level < levels; ++level) {
+	  const std::size_t slot = first_slot(level);
+	  if (slot < slots) {
+	    earliest_m = bucket(level, slot);
+	    for (node_t* node = earliest_m->next_m; level > 0 && node != NULL; node = node->next_m) {
+	      if (node->time_m < earliest_m->time_m) {
+		earliest_m = node;
+	      }
+	    }
+	    break;
+	  }
+	}
+      }
+      return earliest_m;
+    }
+    // Moves the clock to the start of the earliest occupied slot, as
+    // long as that is not after limit, and redistributes the timers
+    // in it. Returns false if there was no such slot.
+    bool step(time_type limit) {
+      for (std::size_t level = 0; level < levels; ++level) {
+	const std::size_t shift = slot_bits * level;
+	const std::size_t slot = first_slot(level);
+	if (slot == slots) {
+	  occupied_m[level] = 0;
+	} else {
+	  occupied_m[level] &= ~((std::uint64_t(1) << slot) - 1);
+	  const time_type span = time_type(1) << (shift + slot_bits);
+	  const time_type start = (now_m & ~(span - 1)) | (time_type(slot) << shift);
+	  if (start > limit) {
+	    return false;
+	  }
+	  now_m = start;
+	  occupied_m[level] &= ~(std::uint64_t(1) << slot);
+	  node_t*& head = bucket(level, slot);
+	  while (head != NULL) {
+	    node_t* node = head;
+	    unlink(node);
+	    place(node);
+	  }
+	  return true;
+	}
+      }
+      if (! overflow_m.empty()) {
+	const time_type span = time_type(1) << (slot_bits * levels);
+	const time_type start = overflow_m.top()->time_m & ~(span - 1);
+	if (start > limit) {
+	  return false;
+	}
+	now_m = start;
+	while (! overflow_m.empty() && level_of(overflow_m.top()->time_m) < levels) {
+	  node_t* node = overflow_m.top();
+	  overflow_m.pop();
+	  node->overflow_m = NULL;
+	  place(node);
+	}
+	return true;
+      }
+      return false;
+    }
+    static std::size_t lowest_bit(std::uint64_t bits) {
+#if defined(__GNUC__)
+      return __builtin_ctzll(bits);
+#else
+      std::size_t result = 0;
+      for (; (bits & 1) == 0; bits >>= 1) {
+	++result;
+      }
+      return result;
+#endif
+    }
+    std::vector<node_t*> buckets_m;
+    std::array<std::uint64_t, levels> occupied_m;
+    overflow_type overflow_m;
+    time_type now_m;
+    std::size_t size_m;
+    time_ex_type time_ex_m;
+    mutable node_t* earliest_m;
+  }; // timer_wheel
+
+
+  template<typename value_T,
+	   typename time_ex_T,
+	   std::size_t levels_N>
+  struct timer_wheel<value_T, time_ex_T, levels_N>::node_t {
+    template<typename... args_T>
+    node_t(args_T&&... args)
+      : value_m(std::forward<args_T>(args)...), time_m(),
+	next_m(NULL), pprev_m(NULL), bucket_m(0), overflow_m(NULL)
+    {}
+    value_type value_m;
+    time_type time_m;
+    node_t* next_m;
+    node_t** pprev_m;
+    // Index of the list the node is on, or one past the due list when
+    // it is in the overflow heap.
+    std::size_t bucket_m;
+    typename overflow_type::handle_type overflow_m;
+  }; // node_t
+
+
+  template<typename value_T,
+	   typename time_ex_T,
+	   std::size_t levels_N>
+  struct timer_wheel<value_T, time_ex_T, levels_N>::handle_type {
+    friend class timer_wheel;
+    handle_type() : node_m(NULL) {}
+    value_type& operator*() const { return node_m->value_m; }
+    value_type* operator->() const { return &node_m->value_m; }
+    bool operator==(const handle_type& x) const { return node_m == x.node_m; }
+    bool operator!=(const handle_type& x) const { return node_m != x.node_m; }
+    value_type& value() const { return node_m->value_m; }
+  protected:
+    explicit handle_type(node_t* node) : node_m(node) {}
+    node_t* node_m;
+  }; // handle_type
+
+
+  template<typename value_T,
+	   std::size_t levels_N = 4,
+	   typename time_ex_T = internal::id_func>
+  timer_wheel<value_T, typename std::decay<time_ex_T>::type, levels_N>
+  make_timer_wheel(typename timer_wheel<value_T, typename std::decay<time_ex_T>::type, levels_N>::time_type now = 0,
+		   time_ex_T&& time_ex = time_ex_T()) {
+    return timer_wheel<value_T, typename std::decay<time_ex_T>::type, levels_N>(now, std::forward<time_ex_T>(time_ex));
+  }
+
+} // namespace com_masaers
+
+
+/******************************************************************************/
+#endif
@@ -0,0 +1,283 @@
+#include "timer_wheel.hpp"
+#include "mutable_heap.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#define _TEST_OUTPUT_PREFIX(stream)		\
+  stream << __FILE__ << ":" << __LINE__ << " "; \
+  
+#define TEST(expr)                                                      \
+  try {									\
+    if (expr) {                                                         \
+      _TEST_OUTPUT_PREFIX(std::cout);                                   \
+      std::cout << #expr << " [PASSED]" << std::endl;                   \
+    } else {								\
+      _TEST_OUTPUT_PREFIX(std::cerr);					\
+      std::cerr << #expr << " [FAILED]" << std::endl;			\
+    }									\
+  } catch (const std::exception& e) {					\
+    _TEST_OUTPUT_PREFIX(std::cerr);                                     \
+    std::cerr << #expr;							\
+      std::cerr << " exception: \"" << e.what() << "\"";                \
+      std::cerr << " [FAILED]" << std::endl;                            \
+  } catch (...) {							\
+    _TEST_OUTPUT_PREFIX(std::cerr);                                     \
+    std::cerr << #expr << " unknown exception [FAILED]" << std::endl;	\
+  }									\
+  
+#define TEST_INFO(...)						       \
+  _TEST_OUTPUT_PREFIX(std::cout);				       \
+  std::cout << #__VA_ARGS__ << " [EXECUTING]" << std::endl;	       \
+  __VA_ARGS__;							       \
+  
+
+struct timer {
+  std::uint64_t time;
+  int id;
+};
+
+struct timer_time {
+  const std::uint64_t& operator()(const timer& x) const { return x.time; }
+};
+
+struct timer_less {
+  bool operator()(const timer& a, const timer& b) const { return a.time < b.time; }
+};
+
+template<typename wheel_T>
+void test_timer_wheel(wheel_T&& w, const char* name) {
+  using namespace std;
+
+  TEST(w.empty());
+  TEST_INFO(w.push(100));
+  TEST_INFO(w.push(5));
+  TEST_INFO(auto x70 = w.push(70));
+  TEST_INFO(auto x1m = w.push(1000000));
+  TEST_INFO(auto x1t = w.push(1000000000000ull));
+  TEST_INFO(w.push(5000));
+  TEST(w.size() == 6);
+  TEST(! w.expired());
+  TEST(w.top() == 5);
+  TEST(w.next_deadline() == 5);
+  TEST(w.now() == 0);
+  TEST_INFO(w.pop());
+  TEST_INFO(w.erase(x70));
+  TEST_INFO(*x1m = 50);
+  TEST(w.maintain_update(x1m));
+  TEST(w.top() == 50);
+  TEST(w.now() == 0);
+  TEST_INFO(w.pop());
+  TEST_INFO(*x1t = 2000000000000ull);
+  TEST(! w.maintain_update(x1t));
+  TEST_INFO(w.advance(4999));
+  TEST(w.expired());
+  TEST(w.top() == 100);
+  TEST_INFO(w.pop());
+  TEST(! w.expired());
+  TEST(w.now() == 4999);
+  TEST_INFO(w.push(10));
+  TEST(w.expired());
+  TEST(w.top() == 10);
+  TEST_INFO(w.pop());
+  TEST(w.top() == 5000);
+  TEST_INFO(w.pop());
+  TEST(w.top() == 2000000000000ull);
+  TEST(w.next_deadline() == 2000000000000ull);
+  TEST(w.now() == 4999);
+  TEST_INFO(w.pop());
+  TEST(w.empty());
+  TEST_INFO(auto y = w.push(3000000000000ull));
+  TEST_INFO(*y = w.now() + 7);
+  TEST(w.maintain_update(y));
+  TEST(w.top() == 5006);
+  TEST_INFO(w.push(1));
+  TEST(w.size() == 2);
+  TEST_INFO(w.clear());
+  TEST(w.empty());
+}
+
+template<typename wheel_T>
+void test_timer_wheel_clock(wheel_T&& w, const char* name) {
+  using namespace std;
+
+  TEST(w.now() == 100);
+  TEST_INFO(w.push(5000));
+  TEST(w.next_deadline() == 5000);
+  TEST(w.top() == 5000);
+  TEST(w.now() == 100);
+  TEST_INFO(w.push(200));
+  TEST_INFO(w.advance(150));
+  TEST(! w.expired());
+  TEST(w.top() == 200);
+  TEST_INFO(w.advance(200));
+  TEST(w.expired());
+  TEST(w.top() == 200);
+  TEST_INFO(w.pop());
+  TEST(! w.expired());
+  TEST_INFO(typename std::decay<wheel_T>::type moved(std::move(w)));
+  TEST(moved.size() == 1);
+  TEST(w.empty());
+  TEST_INFO(w.push(1));
+  TEST(w.expired());
+  TEST_INFO(w.pop());
+  TEST(w.empty());
+  TEST(moved.top() == 5000);
+}
+
+// Many timers sharing one level 2 slot: the earliest deadline must
+// stay exact across pushes, erases and reschedules, and repeated reads
+// must not rescan the slot.
+bool far_future_deadlines() {
+  using namespace std;
+  using namespace com_masaers;
+  auto w = make_timer_wheel<uint64_t>(4095);
+  vector<decltype(w.push(0))> handles;
+  for (uint64_t i = 0; i < 100000; ++i) {
+    handles.push_back(w.push(4097 + (i * 7919) % 4000));
+  }
+  const auto expected = [&]() {
+    uint64_t result = numeric_limits<uint64_t>::max();
+    for (auto it = handles.begin(); it != handles.end(); ++it) {
+      result = min(result, **it);
+    }
+    return result;
+  };
+  bool result = w.next_deadline() == 4097;
+  uint64_t sum = 0;
+  for (int i = 0; i < 100000; ++i) {
+    sum += w.next_deadline();
+  }
+  result = result && sum == 4097ull * 100000;
+  handles.push_back(w.push(4096));
+  result = result && w.next_deadline() == 4096 && w.top() == 4096;
+  w.erase(handles.back());
+  handles.pop_back();
+  result = result && w.next_deadline() == expected();
+  handles.push_back(w.push(1000000000000ull));
+  result = result && w.next_deadline() == 4097;
+  for (size_t i = 0; result && i < 800; ++i) {
+    *handles[i] = 4100 + i;
+    w.maintain_update(handles[i]);
+    result = w.next_deadline() == expected();
+  }
+  *handles.back() = 4098;
+  w.maintain_update(handles.back());
+  result = result && w.next_deadline() == expected();
+  multiset<uint64_t> pending;
+  for (auto it = handles.begin(); it != handles.end(); ++it) {
+    pending.insert(**it);
+  }
+  w.advance(4200);
+  while (result && w.expired()) {
+    const auto it = pending.find(w.top());
+    result = w.top() <= 4200 && it != pending.end();
+    if (result) {
+      pending.erase(it);
+    }
+    w.pop();
+  }
+  return result && w.size() == pending.size()
+    && *pending.begin() > 4200 && w.next_deadline() == *pending.begin();
+}
+
+// Runs the same random schedule/cancel/reschedule/expire trace on a
+// wheel and a heap and checks that both expire the same timers.
+bool same_as_heap(unsigned int seed) {
+  using namespace std;
+  using namespace com_masaers;
+  auto w = make_timer_wheel<timer>(0, timer_time());
+  auto h = make_mutable_min_heap<timer>(timer_less());
+  vector<decltype(w.push(timer()))> wh;
+  vector<decltype(h.push(timer()))> hh;
+  mt19937_64 rng(seed);
+  const auto deadline = [&](uint64_t now) {
+    const int shift = int(rng() % 40);
+    return now + 1 + (rng() & ((uint64_t(1) << shift) - 1));
+  };
+  uint64_t now = 0;
+  for (int id = 0; id < 1000; ++id) {
+    const timer t = { deadline(now), id };
+    wh.push_back(w.push(t));
+    hh.push_back(h.push(t));
+  }
+  bool result = true;
+  for (int op = 0; result && op < 100000; ++op) {
+    const int id = int(rng() % wh.size());
+    switch (rng() % 4) {
+    case 0: {
+      const timer t = { deadline(now), id };
+      w.erase(wh[id]);
+      h.erase(hh[id]);
+      wh[id] = w.push(t);
+      hh[id] = h.push(t);
+      break;
+    }
+    case 1:
+    case 2: {
+      const uint64_t time = deadline(now);
+      wh[id]->time = time;
+      hh[id]->time = time;
+      w.maintain_update(wh[id]);
+      h.maintain_update(hh[id]);
+      break;
+    }
+    default: {
+      now += rng() % 100000;
+      w.advance(now);
+      vector<int> expired;
+      while (w.expired()) {
+	expired.push_back(w.top().id);
+	w.pop();
+      }
+      std::size_t popped = 0;
+      while (! h.empty() && h.top().time <= now) {
+	const int id = h.top().id;
+	++popped;
+	result = result && find(expired.begin(), expired.end(), id) != expired.end();
+	h.pop();
+	const timer t = { deadline(now), id };
+	hh[id] = h.push(t);
+	wh[id] = w.push(t);
+      }
+      result = result && popped == expired.size() && w.size() == h.size();
+      break;
+    }
+    }
+    if (! h.empty()) {
+      result = result && w.next_deadline() == h.top().time;
+    }
+  }
+  while (result && ! h.empty()) {
+    result = w.top().time == h.top().time;
+    w.pop();
+    h.pop();
+  }
+  return result && w.empty();
+}
+
+
+int main(const int argc, const char** argv) {
+  using namespace std;
+  using namespace com_masaers;
+
+  test_timer_wheel(make_timer_wheel<uint64_t>(),
+		   "make_timer_wheel<T>()");
+  test_timer_wheel(make_timer_wheel<uint64_t, 2>(),
+		   "make_timer_wheel<T, 2>()");
+  test_timer_wheel_clock(make_timer_wheel<uint64_t>(100),
+			 "make_timer_wheel<T>(100)");
+  test_timer_wheel_clock(make_timer_wheel<uint64_t, 1>(100),
+			 "make_timer_wheel<T, 1>(100)");
+  TEST(far_future_deadlines());
+  TEST(same_as_heap(1));
+  TEST(same_as_heap(2));
+
+  return EXIT_SUCCESS;
+}
+
+/******************************************************************************/